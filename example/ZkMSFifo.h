@@ -2,6 +2,7 @@
 #define __ZKMSFIFO__
 
 #include <cstdint>
+#include <cstddef>
 #include <memory>
 #include <chrono>
 #include <deque>
@@ -99,4 +100,171 @@ protected:
     mutable std::mutex m_mutex_;
     std::condition_variable m_condition_;
 };
+
+/// Base class of the items queued by ZKMSIntrusiveFifo, the link and the
+/// deleter are kept inside the item so enqueue/dequeue allocate nothing.
+template <typename T, typename D = std::default_delete<T>>
+class ZKFifoHook
+{
+    template <typename, typename, std::size_t> friend class ZKMSIntrusiveFifo;
+    T* m_fifo_next_ = nullptr;
+    D m_fifo_deleter_;
+};
+
+/// Same as ZKMSFifo but the queue is linked through the items themselves,
+/// `T` must derive from `ZKFifoHook<T, D>`. Pair it with ZKObjectPool
+/// (`D = ZKPoolDeleter<T>`) to avoid allocation on the whole path.
+///
+/// Items are kept in `Lanes` priority lanes, lane 0 is the most urgent one;
+/// getNext() always drains a lane before looking at the less urgent ones.
+template <typename T, typename D = std::default_delete<T>, std::size_t Lanes = 1>
+class ZKMSIntrusiveFifo
+{
+    static_assert(Lanes > 0, "ZKMSIntrusiveFifo needs at least one lane");
+public:
+    typedef T* pointer;
+    using hook_t = ZKFifoHook<T, D>;
+    using size_t = std::size_t;
+    using msg_ptr_t = std::unique_ptr<T, D>;
+    using scope_lock_t = std::lock_guard<std::mutex>;
+
+    ZKMSIntrusiveFifo() {}
+    virtual ~ZKMSIntrusiveFifo() {
+        clear();
+    }
+
+    ZKMSIntrusiveFifo(const ZKMSIntrusiveFifo&) = delete;
+    ZKMSIntrusiveFifo& operator=(const ZKMSIntrusiveFifo&) = delete;
+
+    bool empty() const {
+        scope_lock_t locker(m_mutex_);
+        return m_size_ == 0;
+    }
+
+    virtual size_t size() const {
+        scope_lock_t locker(m_mutex_);
+        return m_size_;
+    }
+
+    /// number of elements waiting in the given lane
+    size_t size(size_t lane) const {
+        scope_lock_t locker(m_mutex_);
+        return m_lanes_[clamp_(lane)].m_size_;
+    }
+
+    /// remove and destroy all elements in the queue
+    virtual void clear() {
+        Lane lanes[Lanes];
+        {
+            scope_lock_t locker(m_mutex_);
+            for (size_t i = 0; i < Lanes; ++i)
+            {
+                lanes[i] = m_lanes_[i];
+                m_lanes_[i] = Lane();
+            }
+            m_size_ = 0;
+        }
+        for (auto& lane : lanes)
+        {
+            pointer head = lane.m_head_;
+            while (head)
+            {
+                pointer next = hook_(head)->m_fifo_next_;
+                wrap_(head); // destroy it by its own deleter
+                head = next;
+            }
+        }
+    }
+
+    msg_ptr_t getNext() {
+        std::unique_lock<std::mutex> ulk(m_mutex_);
+
+        // Wait util there are messages available.
+        m_condition_.wait(ulk, [this]() {return m_size_ != 0; });
+
+        return pop_();
+    }
+
+    template< class Rep, class Period>
+    msg_ptr_t getNext(const std::chrono::duration<Rep, Period>& duration) {
+        std::unique_lock<std::mutex> ulk(m_mutex_);
+        bool res = m_condition_.wait_for(ulk, duration, [this]() {return m_size_ != 0; });
+        if (!res)
+        {// timeout
+            return msg_ptr_t(nullptr, D());
+        }
+        return pop_();
+    }
+
+    /// append the item to the given lane, out of range lanes go to the last one
+    size_t add(msg_ptr_t&& item, size_t lane = 0) {
+        if (!item)
+        {
+            return size();
+        }
+        hook_t* hook = hook_(item.get());
+        hook->m_fifo_next_ = nullptr;
+        hook->m_fifo_deleter_ = std::move(item.get_deleter());
+        pointer msg = item.release();
+
+        scope_lock_t locker(m_mutex_);
+        Lane& l = m_lanes_[clamp_(lane)];
+        if (l.m_tail_)
+        {
+            hook_(l.m_tail_)->m_fifo_next_ = msg;
+        }
+        else
+        {
+            l.m_head_ = msg;
+        }
+        l.m_tail_ = msg;
+        ++l.m_size_;
+        m_condition_.notify_one();
+        return ++m_size_;
+    }
+
+protected:
+    struct Lane
+    {
+        pointer m_head_ = nullptr;
+        pointer m_tail_ = nullptr;
+        size_t m_size_ = 0;
+    };
+
+    static size_t clamp_(size_t lane) {
+        return lane < Lanes ? lane : Lanes - 1;
+    }
+
+    static hook_t* hook_(pointer msg) {
+        return static_cast<hook_t*>(msg);
+    }
+
+    static msg_ptr_t wrap_(pointer msg) {
+        return msg_ptr_t(msg, std::move(hook_(msg)->m_fifo_deleter_));
+    }
+
+    // must be called with m_mutex_ held and the queue not empty
+    msg_ptr_t pop_() {
+        Lane* l = m_lanes_;
+        while (!l->m_head_)
+        {
+            ++l;
+        }
+        pointer msg = l->m_head_;
+        l->m_head_ = hook_(msg)->m_fifo_next_;
+        if (!l->m_head_)
+        {
+            l->m_tail_ = nullptr;
+        }
+        --l->m_size_;
+        --m_size_;
+        hook_(msg)->m_fifo_next_ = nullptr;
+        return wrap_(msg);
+    }
+
+    Lane m_lanes_[Lanes];
+    size_t m_size_ = 0;
+    mutable std::mutex m_mutex_;
+    std::condition_variable m_condition_;
+};
 #endif // #ifndef __ZKMSFIFO__
@@ -0,0 +1,147 @@
+#ifndef __ZKOBJECTPOOL__
+#define __ZKOBJECTPOOL__
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class ZKObjectPool;
+
+/// deleter returning the object to the pool it was acquired from,
+/// objects not owned by any pool are released by `delete`
+template <typename T>
+struct ZKPoolDeleter
+{
+    ZKPoolDeleter() = default;
+    explicit ZKPoolDeleter(ZKObjectPool<T>* pool) : m_pool_(pool) {}
+
+    void operator()(T* p) const {
+        if (m_pool_)
+        {
+            m_pool_->release(p);
+        }
+        else
+        {
+            delete p;
+        }
+    }
+
+    ZKObjectPool<T>* m_pool_ = nullptr;
+};
+
+/// Fixed-size object pool, slots are allocated chunk by chunk and recycled
+/// through a free list, so once warmed up acquire/release never touch the heap.
+/// The pool must outlive every object acquired from it.
+template <typename T>
+class ZKObjectPool
+{
+public:
+    using size_t = std::size_t;
+    using deleter_t = ZKPoolDeleter<T>;
+    using obj_ptr_t = std::unique_ptr<T, deleter_t>;
+    using scope_lock_t = std::lock_guard<std::mutex>;
+
+    explicit ZKObjectPool(size_t chunk_size = 64)
+        : m_chunk_size_(chunk_size ? chunk_size : 1) {}
+    ~ZKObjectPool() = default;
+
+    ZKObjectPool(const ZKObjectPool&) = delete;
+    ZKObjectPool& operator=(const ZKObjectPool&) = delete;
+
+    /// construct an object in a free slot, grow by one chunk when exhausted
+    template <typename... Args>
+    obj_ptr_t acquire(Args&&... args) {
+        Slot* slot = pop_();
+        try
+        {
+            T* obj = ::new (static_cast<void*>(&slot->m_storage_)) T(std::forward<Args>(args)...);
+            return obj_ptr_t(obj, deleter_t(this));
+        }
+        catch (...)
+        {
+            push_(slot);
+            throw;
+        }
+    }
+
+    /// destroy the object and put its slot back to the free list
+    void release(T* obj) {
+        if (!obj)
+        {
+            return;
+        }
+        obj->~T();
+        push_(reinterpret_cast<Slot*>(obj));
+    }
+
+    /// preallocate slots for at least `count` objects
+    void reserve(size_t count) {
+        scope_lock_t locker(m_mutex_);
+        while (m_capacity_ < count)
+        {
+            grow_();
+        }
+    }
+
+    size_t capacity() const {
+        scope_lock_t locker(m_mutex_);
+        return m_capacity_;
+    }
+
+    size_t available() const {
+        scope_lock_t locker(m_mutex_);
+        return m_available_;
+    }
+
+private:
+    union Slot
+    {
+        Slot* m_next_;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage_;
+    };
+
+    Slot* pop_() {
+        scope_lock_t locker(m_mutex_);
+        if (!m_free_)
+        {
+            grow_();
+        }
+        Slot* slot = m_free_;
+        m_free_ = slot->m_next_;
+        --m_available_;
+        return slot;
+    }
+
+    void push_(Slot* slot) {
+        scope_lock_t locker(m_mutex_);
+        slot->m_next_ = m_free_;
+        m_free_ = slot;
+        ++m_available_;
+    }
+
+    // must be called with m_mutex_ held
+    void grow_() {
+        std::unique_ptr<Slot[]> chunk(new Slot[m_chunk_size_]);
+        for (size_t i = 0; i < m_chunk_size_; ++i)
+        {
+            chunk[i].m_next_ = m_free_;
+            m_free_ = &chunk[i];
+        }
+        m_chunks_.push_back(std::move(chunk));
+        m_capacity_ += m_chunk_size_;
+        m_available_ += m_chunk_size_;
+    }
+
+    const size_t m_chunk_size_;
+    size_t m_capacity_ = 0;
+    size_t m_available_ = 0;
+    Slot* m_free_ = nullptr;
+    std::vector<std::unique_ptr<Slot[]>> m_chunks_;
+    mutable std::mutex m_mutex_;
+};
+#endif // #ifndef __ZKOBJECTPOOL__
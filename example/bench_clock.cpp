@@ -0,0 +1,100 @@
+// Cost of the clock sources of the logger:
+//   example_bench_clock [calls per clock] [records per clock]
+// prints per clock: nanoseconds per reading, worst offset against the system clock,
+// and nanoseconds per record written to a file sink through the LOG_* stream macros
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "logger_wrapper.h"
+
+using namespace example;
+
+namespace
+{
+    struct clock_case
+    {
+        const char* name;
+        logger::clock_source source;
+    };
+
+    const clock_case s_cases[] = {
+        { "system", logger::clock_source::system },
+        { "coarse", logger::clock_source::coarse },
+        { "tsc", logger::clock_source::tsc },
+        { "cached", logger::clock_source::cached },
+    };
+
+    template <typename Duration>
+    double ns_per(Duration d, long count)
+    {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) / count;
+    }
+
+    double bench_reading(logger::clock_fn clock, long calls)
+    {
+        long long sink = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < calls; ++i)
+        {
+            sink += clock().time_since_epoch().count();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        if (sink == 42)
+        {
+            std::puts(""); // keep the loop
+        }
+        return ns_per(elapsed, calls);
+    }
+
+    // worst absolute offset against the system clock over about 1.5 seconds
+    double worst_offset_us(logger::clock_fn clock)
+    {
+        long long worst = 0;
+        for (int i = 0; i < 300; ++i)
+        {
+            const auto sys = std::chrono::system_clock::now();
+            const auto tested = clock();
+            const long long offset = std::chrono::duration_cast<std::chrono::microseconds>(tested - sys).count();
+            worst = std::max(worst, offset < 0 ? -offset : offset);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return static_cast<double>(worst);
+    }
+
+    double bench_records(const clock_case& c, long records)
+    {
+        auto log = logger::make_multisink_logger(
+            std::string("bench-clock-") + c.name,
+            { logger::make_daily_file_sink("./example-bench-clock.log", "%5!l | %X.%f | %P | %5t | %20!s:%-4# | %v", logger::trace) },
+            logger::trace, c.source);
+        const auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < records; ++i)
+        {
+            LOG_WITH_LOGGER_LEVEL(log, logger::info) << "bench record " << i;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        log->flush();
+        return ns_per(elapsed, records);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const long calls = argc > 1 ? std::max(1L, std::atol(argv[1])) : 10000000L;
+    const long records = argc > 2 ? std::max(1L, std::atol(argv[2])) : 200000L;
+
+    std::printf("%-8s %12s %14s %12s\n", "clock", "ns/reading", "worst us off", "ns/record");
+    for (const auto& c : s_cases)
+    {
+        auto clock = logger::get_clock(c.source);
+        const double reading = bench_reading(clock, calls);
+        const double offset = worst_offset_us(clock);
+        const double record = bench_records(c, records);
+        std::printf("%-8s %12.1f %14.0f %12.1f\n", c.name, reading, offset, record);
+    }
+    logger::shutdown();
+    return 0;
+}
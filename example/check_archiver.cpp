@@ -0,0 +1,114 @@
+// Check of the history handling of log_archiver, run by ctest:
+//   example_check_archiver
+// the files of other loggers sharing the directory and the stem must never be compressed or removed
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "log_archiver.h"
+
+#if defined(_WIN32)
+#   include <direct.h>
+#else
+#   include <sys/stat.h>
+#endif
+
+using namespace example;
+
+namespace
+{
+    const std::string s_dir = "check-archiver";
+
+    std::string path_of(const std::string& name)
+    {
+        return s_dir + "/" + name;
+    }
+
+    bool exists(const std::string& name)
+    {
+        std::FILE* f = std::fopen(path_of(name).c_str(), "rb");
+        if (f)
+        {
+            std::fclose(f);
+        }
+        return f != nullptr;
+    }
+
+    // exists as written or as compressed by the archiver
+    bool exists_any(const std::string& name)
+    {
+        return exists(name) || exists(name + ".gz");
+    }
+
+    void write_file(const std::string& name)
+    {
+        std::FILE* f = std::fopen(path_of(name).c_str(), "wb");
+        if (f)
+        {
+            std::fputs("I | 12:00:00.000000 | record\n", f);
+            std::fclose(f);
+        }
+    }
+
+    int s_failures = 0;
+
+    void expect(bool condition, const std::string& what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+            ++s_failures;
+        }
+    }
+}
+
+int main()
+{
+#if defined(_WIN32)
+    _mkdir(s_dir.c_str());
+#else
+    mkdir(s_dir.c_str(), 0755);
+#endif
+    const char* history[] = { "app_2026-10-14.log", "app_2026-10-15.log", "app_2026-10-16.log", "app_2026-10-17.log" };
+    const char* siblings[] = { "app_debug.log", "app_debug_2026-10-17.log", "app_notes.log", "app_2026-10-17.log.bak", "other_2026-10-17.log" };
+    const std::string current = "app_2026-10-18.log";
+    for (const char* name : history)
+    {
+        std::remove(path_of(std::string(name) + ".gz").c_str());
+        write_file(name);
+    }
+    for (const char* name : siblings)
+    {
+        write_file(name);
+    }
+    write_file(current);
+
+    {
+        // the current file and the two newest days
+        thread_config config;
+        config.name = "check-archiver";
+        logger::log_archiver archiver(path_of("app.log"), 3, 0, config);
+        archiver.sweep(path_of(current));
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while ((exists_any(history[0]) || exists_any(history[1])) && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    expect(exists(current), current + " kept as is");
+    expect(!exists_any(history[0]), std::string(history[0]) + " removed");
+    expect(!exists_any(history[1]), std::string(history[1]) + " removed");
+    expect(exists_any(history[2]), std::string(history[2]) + " kept");
+    expect(exists_any(history[3]), std::string(history[3]) + " kept");
+    for (const char* name : siblings)
+    {
+        expect(exists(name) && !exists(std::string(name) + ".gz"), std::string(name) + " untouched");
+    }
+
+    if (s_failures == 0)
+    {
+        std::printf("log_archiver history check passed\n");
+    }
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Check of ZKObjectPool and ZKMSIntrusiveFifo, run by ctest:
+//   example_check_fifo
+// the pooled items must always come back to their pool, whatever path they leave the queue by,
+// and the priority lanes must be drained in order
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "ZkMSFifo.h"
+#include "ZkObjectPool.h"
+
+namespace
+{
+    struct Item : public ZKFifoHook<Item, ZKPoolDeleter<Item>>
+    {
+        explicit Item(int id) : m_id_(id) { ++s_alive; }
+        ~Item() { --s_alive; }
+        int m_id_;
+        static int s_alive;
+    };
+    int Item::s_alive = 0;
+
+    using ItemPool = ZKObjectPool<Item>;
+    using ItemFifo = ZKMSIntrusiveFifo<Item, ZKPoolDeleter<Item>>;
+    using LaneFifo = ZKMSIntrusiveFifo<Item, ZKPoolDeleter<Item>, 3>;
+
+    int s_failures = 0;
+
+    void expect(bool condition, const std::string& what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what.c_str());
+            ++s_failures;
+        }
+    }
+
+    void check_pool_cycles()
+    {
+        ItemPool pool(4);
+        pool.reserve(8);
+        const auto capacity = pool.capacity();
+        const auto available = pool.available();
+        expect(capacity == 8 && available == 8, "reserve(8) with chunks of 4 gives 8 free slots");
+        for (int cycle = 0; cycle < 1000; ++cycle)
+        {
+            std::vector<ItemPool::obj_ptr_t> items;
+            for (int i = 0; i < 1 + cycle % 8; ++i)
+            {
+                items.push_back(pool.acquire(i));
+            }
+            if (cycle % 2)
+            {
+                items.clear();
+            }
+            else
+            {
+                // release in the acquisition order too
+                for (auto& item : items)
+                {
+                    item.reset();
+                }
+            }
+        }
+        expect(pool.capacity() == capacity, "capacity unchanged after acquire/release cycles");
+        expect(pool.available() == available, "available back to its start value after acquire/release cycles");
+        expect(Item::s_alive == 0, "every item destroyed after acquire/release cycles");
+    }
+
+    void check_fifo_returns_items()
+    {
+        ItemPool pool(4);
+        {
+            ItemFifo fifo;
+            for (int i = 0; i < 6; ++i)
+            {
+                fifo.add(pool.acquire(i));
+            }
+            expect(fifo.size() == 6, "size() counts the queued items");
+            expect(pool.available() == pool.capacity() - 6, "queued items hold their slots");
+
+            auto item = fifo.getNext();
+            expect(item && item->m_id_ == 0, "getNext() returns the oldest item");
+            item.reset();
+            expect(pool.available() == pool.capacity() - 5, "an item taken by getNext() goes back to the pool");
+
+            fifo.clear();
+            expect(fifo.empty() && fifo.size() == 0, "clear() empties the queue");
+            expect(pool.available() == pool.capacity(), "clear() returns the items to the pool");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                fifo.add(pool.acquire(i));
+            }
+        }
+        expect(pool.available() == pool.capacity(), "the destructor returns the items to the pool");
+        expect(Item::s_alive == 0, "every queued item destroyed");
+
+        ItemFifo fifo;
+        fifo.add(pool.acquire(1));
+        expect(fifo.add(ItemPool::obj_ptr_t()) == 1, "add(nullptr) returns the unchanged size");
+        expect(fifo.size() == 1, "add(nullptr) queues nothing");
+        expect(fifo.getNext()->m_id_ == 1, "add(nullptr) leaves the queued item in place");
+        expect(!fifo.getNext(std::chrono::milliseconds(1)), "add(nullptr) leaves nothing to get");
+    }
+
+    bool sizes_agree(const LaneFifo& fifo)
+    {
+        return fifo.size() == fifo.size(0) + fifo.size(1) + fifo.size(2);
+    }
+
+    void check_lanes()
+    {
+        ItemPool pool(8);
+        LaneFifo fifo;
+        // ids: lane * 100 + rank in the lane, lane 7 is out of range and goes to lane 2
+        fifo.add(pool.acquire(100), 1);
+        fifo.add(pool.acquire(200), 2);
+        fifo.add(pool.acquire(0), 0);
+        fifo.add(pool.acquire(201), 7);
+        fifo.add(pool.acquire(101), 1);
+        fifo.add(pool.acquire(1), 0);
+        expect(fifo.size(0) == 2 && fifo.size(1) == 2 && fifo.size(2) == 2, "items counted in their lanes");
+        expect(fifo.size(7) == fifo.size(2), "size() of an out of range lane is the one of the last lane");
+        expect(sizes_agree(fifo), "size() is the sum of the lane sizes after add()");
+
+        const int expected[] = { 0, 1, 100, 101, 200, 201 };
+        for (int id : expected)
+        {
+            auto item = fifo.getNext();
+            expect(item && item->m_id_ == id, "lanes drained in order, FIFO within a lane: expected " + std::to_string(id) +
+                ", got " + (item ? std::to_string(item->m_id_) : std::string("nothing")));
+            expect(sizes_agree(fifo), "size() is the sum of the lane sizes after getNext()");
+        }
+        expect(fifo.empty(), "all lanes drained");
+
+        // a more urgent item added later still comes first
+        fifo.add(pool.acquire(200), 2);
+        fifo.add(pool.acquire(100), 1);
+        expect(fifo.getNext()->m_id_ == 100, "lane 1 before lane 2");
+        fifo.add(pool.acquire(0), 0);
+        expect(fifo.getNext()->m_id_ == 0, "lane 0 added later before lane 2");
+        expect(sizes_agree(fifo) && fifo.size() == 1 && fifo.size(2) == 1, "sizes after mixed add/getNext");
+
+        fifo.add(pool.acquire(1), 0);
+        fifo.clear();
+        expect(fifo.size() == 0 && fifo.size(0) == 0 && fifo.size(1) == 0 && fifo.size(2) == 0, "clear() empties every lane");
+        fifo.add(pool.acquire(102), 1);
+        expect(sizes_agree(fifo) && fifo.size() == 1 && fifo.size(1) == 1, "sizes after clear() and add()");
+        expect(fifo.getNext()->m_id_ == 102, "queue usable after clear()");
+        expect(pool.available() == pool.capacity(), "every lane item back in the pool");
+    }
+}
+
+int main()
+{
+    check_pool_cycles();
+    check_fifo_returns_items();
+    check_lanes();
+
+    if (s_failures == 0)
+    {
+        std::printf("pool/fifo check passed\n");
+    }
+    return s_failures == 0 ? 0 : 1;
+}
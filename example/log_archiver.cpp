@@ -0,0 +1,333 @@
+#include "log_archiver.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <dirent.h>
+#   include <sys/stat.h>
+#endif
+
+#if defined(ENABLE_LOG_COMPRESSION)
+#   include <zlib.h>
+#endif
+
+namespace example
+{
+    namespace logger
+    {
+        namespace
+        {
+            struct file_entry
+            {
+                std::string name;
+                uint64_t size;
+                // `YYYY-MM-DD` of the history files, sorts chronologically
+                std::string date;
+            };
+
+            std::string::size_type last_separator(const std::string& path)
+            {
+#if defined(_WIN32)
+                return path.find_last_of("\\/");
+#else
+                return path.rfind('/');
+#endif
+            }
+
+            std::string basename_of(const std::string& path)
+            {
+                auto pos = last_separator(path);
+                return pos == std::string::npos ? path : path.substr(pos + 1);
+            }
+
+            // date of `<stem>_YYYY-MM-DD<ext>` or `<stem>_YYYY-MM-DD<ext>.gz`, the names of
+            // spdlog's daily_filename_calculator, empty for any other file
+            std::string history_date(const std::string& name, const std::string& stem, const std::string& ext)
+            {
+                static const char s_date_format[] = "dddd-dd-dd";
+                static const size_t s_date_size = sizeof(s_date_format) - 1;
+                const size_t date_pos = stem.size() + 1;
+                if (name.compare(0, stem.size(), stem) != 0 || name.size() < date_pos + s_date_size || name[stem.size()] != '_')
+                {
+                    return std::string();
+                }
+                for (size_t i = 0; i < s_date_size; ++i)
+                {
+                    const char c = name[date_pos + i];
+                    if (s_date_format[i] == 'd' ? (c < '0' || c > '9') : c != s_date_format[i])
+                    {
+                        return std::string();
+                    }
+                }
+                const std::string suffix = name.substr(date_pos + s_date_size);
+                if (suffix != ext && suffix != ext + ".gz")
+                {
+                    return std::string();
+                }
+                return name.substr(date_pos, s_date_size);
+            }
+
+            // regular files of the directory with their sizes
+            std::vector<file_entry> list_files(const std::string& dir)
+            {
+                std::vector<file_entry> files;
+#if defined(_WIN32)
+                WIN32_FIND_DATAA data;
+                HANDLE handle = FindFirstFileA((dir + "\\*").c_str(), &data);
+                if (handle == INVALID_HANDLE_VALUE)
+                {
+                    return files;
+                }
+                do
+                {
+                    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+                    {
+                        files.push_back({ data.cFileName, (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow, std::string() });
+                    }
+                } while (FindNextFileA(handle, &data));
+                FindClose(handle);
+#else
+                DIR* d = opendir(dir.c_str());
+                if (!d)
+                {
+                    return files;
+                }
+                while (dirent* entry = readdir(d))
+                {
+                    struct stat st;
+                    if (stat((dir + "/" + entry->d_name).c_str(), &st) == 0 && S_ISREG(st.st_mode))
+                    {
+                        files.push_back({ entry->d_name, static_cast<uint64_t>(st.st_size), std::string() });
+                    }
+                }
+                closedir(d);
+#endif
+                return files;
+            }
+
+#if defined(ENABLE_LOG_COMPRESSION)
+            bool ends_with(const std::string& str, const std::string& suffix)
+            {
+                return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+            }
+
+            // move the complete archive `tmp` to `dst`, if `dst` already exists (the same day logged
+            // again after a clock change) `tmp` is appended as another gzip member instead of replacing it
+            bool publish_archive(const std::string& tmp, const std::string& dst)
+            {
+                std::FILE* existing = std::fopen(dst.c_str(), "rb");
+                if (!existing)
+                {
+                    return std::rename(tmp.c_str(), dst.c_str()) == 0;
+                }
+                std::fclose(existing);
+
+                std::FILE* in = std::fopen(tmp.c_str(), "rb");
+                std::FILE* out = std::fopen(dst.c_str(), "ab");
+                bool ok = in && out;
+                std::vector<char> buffer(64 * 1024);
+                size_t n;
+                while (ok && (n = std::fread(buffer.data(), 1, buffer.size(), in)) > 0)
+                {
+                    ok = std::fwrite(buffer.data(), 1, n, out) == n;
+                }
+                ok = ok && !std::ferror(in);
+                if (in)
+                {
+                    std::fclose(in);
+                }
+                if (out)
+                {
+                    ok = std::fclose(out) == 0 && ok;
+                }
+                std::remove(tmp.c_str());
+                return ok;
+            }
+
+            // gzip `src` into `dst`, `src` is removed on success only
+            bool gzip_file(const std::string& src, const std::string& dst)
+            {
+                std::FILE* in = std::fopen(src.c_str(), "rb");
+                if (!in)
+                {
+                    return false;
+                }
+                const std::string tmp = dst + ".tmp";
+                gzFile out = gzopen(tmp.c_str(), "wb6");
+                if (!out)
+                {
+                    std::fclose(in);
+                    return false;
+                }
+                std::vector<char> buffer(64 * 1024);
+                bool ok = true;
+                size_t n;
+                while ((n = std::fread(buffer.data(), 1, buffer.size(), in)) > 0)
+                {
+                    if (gzwrite(out, buffer.data(), static_cast<unsigned>(n)) != static_cast<int>(n))
+                    {
+                        ok = false;
+                        break;
+                    }
+                }
+                ok = !std::ferror(in) && ok;
+                std::fclose(in);
+                ok = gzclose(out) == Z_OK && ok;
+                if (ok)
+                {
+                    ok = publish_archive(tmp, dst);
+                }
+                std::remove(ok ? src.c_str() : tmp.c_str());
+                return ok;
+            }
+#endif
+        } // namespace
+
+        log_archiver::log_archiver(const std::string& base_filename, uint16_t max_files, uint64_t max_total_bytes,
+            const thread_config& config)
+            : max_files_(max_files)
+            , max_total_bytes_(max_total_bytes)
+            , thread_config_(config)
+        {
+            auto sep = last_separator(base_filename);
+            dir_ = sep == std::string::npos ? std::string(".") : base_filename.substr(0, sep);
+            if (dir_.empty())
+            {
+                dir_ = "/";
+            }
+            // same split as spdlog's file_helper::split_by_extension
+            auto name = basename_of(base_filename);
+            auto dot = name.rfind('.');
+            if (dot == std::string::npos || dot == 0 || dot == name.size() - 1)
+            {
+                stem_ = name;
+            }
+            else
+            {
+                stem_ = name.substr(0, dot);
+                ext_ = name.substr(dot);
+            }
+
+            thread_ = std::thread(&log_archiver::run_, this);
+        }
+
+        log_archiver::~log_archiver()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                active_ = false;
+            }
+            cv_.notify_one();
+            thread_.join();
+        }
+
+        void log_archiver::sweep(const std::string& current_filename)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pending_ = true;
+                pending_current_ = current_filename;
+            }
+            cv_.notify_one();
+        }
+
+        void log_archiver::run_()
+        {
+            apply_thread_config_or_warn(thread_config_);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true)
+            {
+                cv_.wait(lock, [this]() { return pending_ || !active_; });
+                if (!active_)
+                {
+                    break; // leftovers are handled by the next sweep after restart
+                }
+                std::string current = std::move(pending_current_);
+                pending_ = false;
+                lock.unlock();
+                try
+                {
+                    sweep_now_(current);
+                }
+                catch (const std::exception& ex)
+                {
+                    std::cerr << "log_archiver: " << ex.what() << std::endl;
+                }
+                lock.lock();
+            }
+        }
+
+        void log_archiver::sweep_now_(const std::string& current_filename)
+        {
+            const std::string current = basename_of(current_filename);
+
+            // only the dated files of this sink, other loggers may share the directory and the stem
+            // (`app_debug_<date>.log` next to `app_<date>.log`)
+            std::vector<file_entry> history;
+            uint64_t current_size = 0;
+            for (auto& file : list_files(dir_))
+            {
+                if (file.name == current)
+                {
+                    current_size = file.size;
+                    continue;
+                }
+                file.date = history_date(file.name, stem_, ext_);
+                if (!file.date.empty())
+                {
+                    history.push_back(std::move(file));
+                }
+            }
+
+#if defined(ENABLE_LOG_COMPRESSION)
+            for (auto& file : history)
+            {
+                if (ends_with(file.name, ".gz"))
+                {
+                    continue;
+                }
+                const std::string src = dir_ + "/" + file.name;
+                if (gzip_file(src, src + ".gz"))
+                {
+                    file.name += ".gz";
+                    std::FILE* f = std::fopen((src + ".gz").c_str(), "rb");
+                    if (f)
+                    {
+                        std::fseek(f, 0, SEEK_END);
+                        file.size = static_cast<uint64_t>(std::ftell(f));
+                        std::fclose(f);
+                    }
+                }
+                else
+                {
+                    std::cerr << "log_archiver: failed to compress " << src << std::endl;
+                }
+            }
+#endif
+
+            // keep the newest ones
+            std::sort(history.begin(), history.end(), [](const file_entry& a, const file_entry& b) {
+                return a.date != b.date ? a.date > b.date : a.name > b.name;
+            });
+            size_t count = 1;
+            uint64_t total = current_size;
+            bool over_limit = false;
+            for (const auto& file : history)
+            {
+                ++count;
+                total += file.size;
+                over_limit = over_limit || (max_files_ > 0 && count > max_files_) || (max_total_bytes_ > 0 && total > max_total_bytes_);
+                if (over_limit)
+                {
+                    std::remove((dir_ + "/" + file.name).c_str());
+                }
+            }
+        }
+    } // namespace logger
+} // namespace example
@@ -0,0 +1,55 @@
+#ifndef __LOG_ARCHIVER__
+#define __LOG_ARCHIVER__
+
+#include <cstdint>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "thread_config.h"
+
+namespace example
+{
+    namespace logger
+    {
+        // Keeps the history of a daily rotated log small: compresses the closed files
+        // (`<stem>_YYYY-MM-DD<ext>` -> `<stem>_YYYY-MM-DD<ext>.gz`, only when built with
+        // ENABLE_LOG_COMPRESSION) and removes the oldest ones beyond `max_files` or
+        // `max_total_bytes`, all of it on a low priority background thread.
+        // Any other file of the directory is left alone, even with the same stem.
+        class log_archiver
+        {
+        public:
+            // `base_filename` is the file name given to the daily sink, 0 means no limit,
+            // the background thread applies `config` on start
+            log_archiver(const std::string& base_filename, uint16_t max_files, uint64_t max_total_bytes,
+                const thread_config& config);
+            ~log_archiver();
+            log_archiver(const log_archiver& other) = delete;
+            log_archiver& operator=(const log_archiver& other) = delete;
+
+            // schedule a pass over the history, `current_filename` is the file in use and is never touched
+            void sweep(const std::string& current_filename);
+
+        private:
+            void run_();
+            void sweep_now_(const std::string& current_filename);
+
+            std::string dir_;
+            std::string stem_;
+            std::string ext_;
+            const uint16_t max_files_;
+            const uint64_t max_total_bytes_;
+            const thread_config thread_config_;
+
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            bool active_ = true;
+            bool pending_ = false;
+            std::string pending_current_;
+            std::thread thread_;
+        };
+    } // namespace logger
+} // namespace example
+
+#endif // #ifndef __LOG_ARCHIVER__
@@ -0,0 +1,240 @@
+#include "log_clock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   else
+#       include <x86intrin.h>
+#   endif
+#   define LOG_CLOCK_HAS_TSC 1
+#elif defined(__aarch64__)
+#   define LOG_CLOCK_HAS_TSC 1
+#endif
+
+namespace example
+{
+    namespace logger
+    {
+        namespace
+        {
+            using time_point = std::chrono::system_clock::time_point;
+            using duration = std::chrono::system_clock::duration;
+
+            int64_t to_ns(time_point tp)
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+            }
+
+            time_point from_ns(int64_t ns)
+            {
+                return time_point(std::chrono::duration_cast<duration>(std::chrono::nanoseconds(ns)));
+            }
+
+            time_point system_now()
+            {
+                return std::chrono::system_clock::now();
+            }
+
+            time_point coarse_now()
+            {
+#if defined(CLOCK_REALTIME_COARSE)
+                timespec ts;
+                clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+                return from_ns(static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec);
+#else
+                return std::chrono::system_clock::now();
+#endif
+            }
+
+#if defined(LOG_CLOCK_HAS_TSC)
+            inline uint64_t read_ticks()
+            {
+#if defined(__aarch64__)
+                uint64_t ticks;
+                asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+                return ticks;
+#else
+                return __rdtsc();
+#endif
+            }
+
+            // cycle counter mapped on the wall clock, the mapping is refreshed every 100ms
+            // so the drift of the estimated frequency never accumulates
+            class tsc_clock
+            {
+            public:
+                static tsc_clock& instance()
+                {
+                    static tsc_clock s_instance;
+                    return s_instance;
+                }
+                time_point now()
+                {
+                    uint32_t seq;
+                    uint64_t anchor_ticks;
+                    int64_t anchor_ns;
+                    double ns_per_tick;
+                    do
+                    {
+                        seq = seq_.load(std::memory_order_acquire);
+                        anchor_ticks = anchor_ticks_.load(std::memory_order_relaxed);
+                        anchor_ns = anchor_ns_.load(std::memory_order_relaxed);
+                        ns_per_tick = ns_per_tick_.load(std::memory_order_relaxed);
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                    } while ((seq & 1) || seq != seq_.load(std::memory_order_relaxed));
+
+                    // read after the anchor so that it is never older than the anchor
+                    const uint64_t ticks = read_ticks();
+                    const uint64_t elapsed = ticks - anchor_ticks;
+                    if (elapsed > reanchor_ticks_.load(std::memory_order_relaxed))
+                    {
+                        reanchor_();
+                    }
+                    return from_ns(anchor_ns + static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(elapsed)) * ns_per_tick));
+                }
+            private:
+                tsc_clock()
+                {
+#if defined(__aarch64__)
+                    uint64_t freq;
+                    asm volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+                    const double ns_per_tick = 1e9 / static_cast<double>(freq);
+#else
+                    // the TSC frequency is not exposed, measure it once against the system clock
+                    const uint64_t ticks0 = read_ticks();
+                    const int64_t ns0 = to_ns(std::chrono::system_clock::now());
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    const uint64_t ticks1 = read_ticks();
+                    const int64_t ns1 = to_ns(std::chrono::system_clock::now());
+                    const double ns_per_tick = static_cast<double>(ns1 - ns0) / static_cast<double>(ticks1 - ticks0);
+#endif
+                    ns_per_tick_.store(ns_per_tick, std::memory_order_relaxed);
+                    reanchor_ticks_.store(static_cast<uint64_t>(1e8 / ns_per_tick), std::memory_order_relaxed);
+                    anchor_ticks_.store(read_ticks(), std::memory_order_relaxed);
+                    anchor_ns_.store(to_ns(std::chrono::system_clock::now()), std::memory_order_release);
+                }
+                void reanchor_()
+                {
+                    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+                    if (!lock.owns_lock())
+                    {
+                        return; // another thread is doing it, keep the current anchor meanwhile
+                    }
+                    const uint64_t old_ticks = anchor_ticks_.load(std::memory_order_relaxed);
+                    const int64_t old_ns = anchor_ns_.load(std::memory_order_relaxed);
+                    double ns_per_tick = ns_per_tick_.load(std::memory_order_relaxed);
+                    const uint64_t ticks = read_ticks();
+                    const int64_t ns = to_ns(std::chrono::system_clock::now());
+                    if (ticks - old_ticks <= reanchor_ticks_.load(std::memory_order_relaxed))
+                    {
+                        return; // done by another thread in the meantime
+                    }
+                    // refine the frequency over the whole interval, ignore the wall clock steps
+                    const double measured = static_cast<double>(ns - old_ns) / static_cast<double>(ticks - old_ticks);
+                    if (measured > ns_per_tick * 0.99 && measured < ns_per_tick * 1.01)
+                    {
+                        ns_per_tick = measured;
+                    }
+
+                    const uint32_t seq = seq_.load(std::memory_order_relaxed);
+                    seq_.store(seq + 1, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    anchor_ticks_.store(ticks, std::memory_order_relaxed);
+                    anchor_ns_.store(ns, std::memory_order_relaxed);
+                    ns_per_tick_.store(ns_per_tick, std::memory_order_relaxed);
+                    seq_.store(seq + 2, std::memory_order_release);
+                }
+
+                // seqlock protecting the anchor, odd while it is updated
+                std::atomic<uint32_t> seq_{ 0 };
+                std::atomic<uint64_t> anchor_ticks_{ 0 };
+                std::atomic<int64_t> anchor_ns_{ 0 };
+                std::atomic<double> ns_per_tick_{ 1.0 };
+                std::atomic<uint64_t> reanchor_ticks_{ 0 };
+                std::mutex mutex_;
+            };
+
+            time_point tsc_now()
+            {
+                return tsc_clock::instance().now();
+            }
+#endif
+
+            // wall clock sampled every millisecond by a background thread
+            class cached_clock
+            {
+            public:
+                static cached_clock& instance(const thread_config& config = thread_config())
+                {
+                    static cached_clock s_instance(config);
+                    return s_instance;
+                }
+                time_point now() const
+                {
+                    return from_ns(now_ns_.load(std::memory_order_relaxed));
+                }
+            private:
+                explicit cached_clock(const thread_config& config)
+                    : now_ns_(to_ns(std::chrono::system_clock::now()))
+                {
+                    thread_ = std::thread([this, config]() {
+                        apply_thread_config_or_warn(config);
+                        while (active_.load(std::memory_order_relaxed))
+                        {
+                            now_ns_.store(to_ns(std::chrono::system_clock::now()), std::memory_order_relaxed);
+                            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                        }
+                    });
+                }
+                ~cached_clock()
+                {
+                    active_.store(false, std::memory_order_relaxed);
+                    thread_.join();
+                }
+                std::atomic<int64_t> now_ns_;
+                std::atomic<bool> active_{ true };
+                std::thread thread_;
+            };
+
+            time_point cached_now()
+            {
+                return cached_clock::instance().now();
+            }
+        } // namespace
+
+        thread_config default_clock_thread_config()
+        {
+            thread_config config;
+            config.name = "log-clock";
+            return config;
+        }
+
+        clock_fn get_clock(clock_source source, const thread_config& config)
+        {
+            switch (source)
+            {
+            case clock_source::coarse:
+                return &coarse_now;
+            case clock_source::tsc:
+#if defined(LOG_CLOCK_HAS_TSC)
+                tsc_clock::instance(); // calibrate now rather than on the first record
+                return &tsc_now;
+#else
+                return &coarse_now;
+#endif
+            case clock_source::cached:
+                cached_clock::instance(config);
+                return &cached_now;
+            case clock_source::system:
+            default:
+                return &system_now;
+            }
+        }
+    } // namespace logger
+} // namespace example
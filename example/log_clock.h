@@ -0,0 +1,37 @@
+#ifndef __LOG_CLOCK__
+#define __LOG_CLOCK__
+
+#include <chrono>
+#include "thread_config.h"
+
+namespace example
+{
+    namespace logger
+    {
+        // where the timestamps of the log records come from, it applies to the records of the
+        // LOG_* and LOG_*_FMT macros, records logged on the spdlog instance itself (impl()) use spdlog's clock
+        enum class clock_source {
+            // std::chrono::system_clock::now(), exact but may be a syscall without vDSO
+            system,
+            // CLOCK_REALTIME_COARSE, resolution of a scheduler tick (1-10ms), system clock elsewhere
+            coarse,
+            // cycle counter (TSC on x86, CNTVCT on aarch64) anchored to the wall clock every 100ms,
+            // coarse clock on other targets
+            tsc,
+            // timestamp refreshed every millisecond by a background thread
+            cached
+        };
+
+        using clock_fn = std::chrono::system_clock::time_point (*)();
+
+        // settings of the background thread of the cached clock: named `log-clock`
+        thread_config default_clock_thread_config();
+
+        // get the function reading the given clock, it calibrates the cycle counter or
+        // starts the background thread the first time they are requested, the thread is
+        // shared by all the loggers and applies the `config` of that first request
+        clock_fn get_clock(clock_source source, const thread_config& config = default_clock_thread_config());
+    } // namespace logger
+} // namespace example
+
+#endif // #ifndef __LOG_CLOCK__
@@ -1,11 +1,25 @@
 #include  "logger_wrapper.h"
+#include  "log_archiver.h"
+
+#include <algorithm>
+#include <thread>
+#include <condition_variable>
+#include <cstdio>
+
+#if defined(_WIN32)
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
 
 #if defined(ENABLE_SPDLOG)
+#   include "spdlog/spdlog.h"
+#   include "spdlog/async.h"
 #   include "spdlog/sinks/stdout_color_sinks.h"
 #   include "spdlog/sinks/daily_file_sink.h"
 #   include "spdlog/sinks/basic_file_sink.h"
+#   include "spdlog/sinks/base_sink.h"
 #else
-#   include <thread>
 #   include <iomanip>
 #   include <ctime>
 #endif
@@ -16,7 +30,171 @@ namespace example
     {
         namespace wrapper
         {
-#if !defined(ENABLE_SPDLOG)
+            // batching of the console output when stdout is not a terminal
+            static const size_t s_max_buffered_lines = 64;
+            static const std::chrono::seconds s_max_buffered_interval{ 1 };
+
+            static bool stdout_is_terminal()
+            {
+#if defined(_WIN32)
+                return _isatty(_fileno(stdout)) != 0;
+#else
+                return isatty(fileno(stdout)) != 0;
+#endif
+            }
+
+#if defined(ENABLE_SPDLOG)
+            // plain stdout sink writing the formatted records in batches, unlike the
+            // spdlog console sinks it does not take the global console mutex
+            class buffered_stdout_sink final : public spdlog::sinks::base_sink<std::mutex>
+            {
+            public:
+                buffered_stdout_sink() = default;
+                ~buffered_stdout_sink() override
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    flush_();
+                }
+            protected:
+                void sink_it_(const spdlog::details::log_msg& msg) override
+                {
+                    formatter_->format(msg, buffer_);
+                    if (++buffered_lines_ >= s_max_buffered_lines || msg.time - last_write_ >= s_max_buffered_interval)
+                    {
+                        write_buffer_(msg.time);
+                    }
+                }
+                void flush_() override
+                {
+                    write_buffer_(spdlog::log_clock::now());
+                    std::fflush(stdout);
+                }
+            private:
+                void write_buffer_(spdlog::log_clock::time_point now)
+                {
+                    if (buffer_.size() > 0)
+                    {
+                        std::fwrite(buffer_.data(), 1, buffer_.size(), stdout);
+                        buffer_.clear();
+                    }
+                    buffered_lines_ = 0;
+                    last_write_ = now;
+                }
+                spdlog::memory_buf_t buffer_;
+                size_t buffered_lines_ = 0;
+                spdlog::log_clock::time_point last_write_;
+            };
+
+            // daily file sink like spdlog's one, the rotated files are handed over to a log_archiver
+            class daily_archiving_file_sink final : public spdlog::sinks::base_sink<std::mutex>
+            {
+            public:
+                daily_archiving_file_sink(std::string base_filename, int rotation_hour, int rotation_minute, bool truncate,
+                    uint16_t max_files, uint64_t max_total_bytes, const thread_config& archiver_config)
+                    : base_filename_(std::move(base_filename))
+                    , rotation_h_(rotation_hour)
+                    , rotation_m_(rotation_minute)
+                    , truncate_(truncate)
+                    , archiver_(base_filename_, max_files, max_total_bytes, archiver_config)
+                {
+                    if (rotation_hour < 0 || rotation_hour > 23 || rotation_minute < 0 || rotation_minute > 59)
+                    {
+                        spdlog::throw_spdlog_ex("daily_archiving_file_sink: Invalid rotation time in ctor");
+                    }
+                    file_helper_.open(spdlog::sinks::daily_filename_calculator::calc_filename(base_filename_, now_tm_(spdlog::log_clock::now())), truncate_);
+                    rotation_tp_ = next_rotation_tp_();
+                    // archive what previous runs left behind
+                    archiver_.sweep(file_helper_.filename());
+                }
+            protected:
+                void sink_it_(const spdlog::details::log_msg& msg) override
+                {
+                    const bool should_rotate = msg.time >= rotation_tp_;
+                    if (should_rotate)
+                    {
+                        file_helper_.open(spdlog::sinks::daily_filename_calculator::calc_filename(base_filename_, now_tm_(msg.time)), truncate_);
+                        rotation_tp_ = next_rotation_tp_();
+                    }
+                    spdlog::memory_buf_t formatted;
+                    formatter_->format(msg, formatted);
+                    file_helper_.write(formatted);
+                    if (should_rotate)
+                    {
+                        archiver_.sweep(file_helper_.filename());
+                    }
+                }
+                void flush_() override
+                {
+                    file_helper_.flush();
+                }
+            private:
+                static std::tm now_tm_(spdlog::log_clock::time_point tp)
+                {
+                    return spdlog::details::os::localtime(spdlog::log_clock::to_time_t(tp));
+                }
+                spdlog::log_clock::time_point next_rotation_tp_() const
+                {
+                    auto now = spdlog::log_clock::now();
+                    std::tm date = now_tm_(now);
+                    date.tm_hour = rotation_h_;
+                    date.tm_min = rotation_m_;
+                    date.tm_sec = 0;
+                    auto rotation_time = spdlog::log_clock::from_time_t(std::mktime(&date));
+                    if (rotation_time > now)
+                    {
+                        return rotation_time;
+                    }
+                    return rotation_time + std::chrono::hours(24);
+                }
+                const std::string base_filename_;
+                const int rotation_h_;
+                const int rotation_m_;
+                const bool truncate_;
+                spdlog::log_clock::time_point rotation_tp_;
+                spdlog::details::file_helper file_helper_;
+                // declared last, its thread stops before the file is closed
+                log_archiver archiver_;
+            };
+
+            static_assert(static_cast<int>(logger::trace) == spdlog::level::trace &&
+                static_cast<int>(logger::info) == spdlog::level::info &&
+                static_cast<int>(logger::critical) == spdlog::level::critical &&
+                static_cast<int>(logger::n_levels) == spdlog::level::n_levels,
+                "logger::level_enum must match spdlog::level::level_enum");
+
+            static inline spdlog::level::level_enum to_spdlog_level(level_enum log_level)
+            {
+                return static_cast<spdlog::level::level_enum>(log_level);
+            }
+
+            logger_t::logger_t(std::shared_ptr<spdlog::logger> impl)
+                : impl_(std::move(impl))
+            {
+            }
+            logger_t::~logger_t()
+            {
+            }
+            void logger_t::set_level(level_enum log_level)
+            {
+                impl_->set_level(to_spdlog_level(log_level));
+            }
+            level_enum logger_t::level() const
+            {
+                return static_cast<level_enum>(impl_->level());
+            }
+            bool logger_t::should_log(level_enum msg_level) const
+            {
+                return impl_->should_log(to_spdlog_level(msg_level));
+            }
+            void logger_t::flush_on(level_enum log_level)
+            {
+                impl_->flush_on(to_spdlog_level(log_level));
+            }
+            void logger_t::flush()
+            {
+                impl_->flush();
+            }
+#else
             void sink::set_level(level_enum log_level)
             {
                 level_.store(log_level, std::memory_order_relaxed);
@@ -30,7 +208,11 @@ namespace example
                 return msg_level >= level_.load(std::memory_order_relaxed);
             }
 
-            console_sink::console_sink() : out_(std::cout), mutex_(mutex())
+            console_sink::console_sink(bool buffered)
+                : out_(std::cout)
+                , mutex_(mutex())
+                , buffered_(buffered)
+                , last_write_(std::chrono::steady_clock::now())
             {
             }
             console_sink::~console_sink()
@@ -40,13 +222,35 @@ namespace example
             void console_sink::log(const std::string& msg)
             {
                 std::lock_guard<std::mutex> lock(mutex_);
-                out_ << msg;
+                if (!buffered_)
+                {
+                    out_ << msg;
+                    return;
+                }
+                buffer_ += msg;
+                if (++buffered_lines_ >= s_max_buffered_lines ||
+                    std::chrono::steady_clock::now() - last_write_ >= s_max_buffered_interval)
+                {
+                    write_buffer_();
+                }
             }
             void console_sink::flush()
             {
                 std::lock_guard<std::mutex> lock(mutex_);
+                write_buffer_();
                 out_.flush();
             }
+            // must be called with mutex_ held
+            void console_sink::write_buffer_()
+            {
+                if (!buffer_.empty())
+                {
+                    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+                    buffer_.clear();
+                }
+                buffered_lines_ = 0;
+                last_write_ = std::chrono::steady_clock::now();
+            }
 
             file_sink::file_sink(const std::string& filepath, bool truncate)
                 : base_filename_()
@@ -87,6 +291,11 @@ namespace example
                 flush_level_.store(log_level);
             }
 
+            void logger_t::flush()
+            {
+                flush_();
+            }
+
             void logger_t::write_log(level_enum msg_level, const std::string& msg)
             {
                 for (auto& sink : sinks_)
@@ -141,6 +350,8 @@ namespace example
                 }
             }
 
+#endif
+
             manager& manager::instance()
             {
                 static manager s_instance;
@@ -149,106 +360,357 @@ namespace example
 
             manager::manager()
             {
+#if defined(ENABLE_SPDLOG)
+                default_logger_ = std::make_shared<logger_t>(spdlog::default_logger());
+#else
                 auto sink = make_colored_console_sink("", logger::trace);
                 sinks_init_list sinks = {sink};
                 default_logger_ = std::make_shared<logger_t>("", sinks);
+#endif
             }
 
             void manager::set_default_logger(logger_ptr logger)
             {
-                // remove previous default logger from the map
-                if (default_logger_ != nullptr)
-                {
-                    default_logger_.reset();
-                }
+                std::lock_guard<std::mutex> lock(mutex_);
                 default_logger_ = std::move(logger);
             }
             logger_ptr manager::get_default_logger()
             {
+                std::lock_guard<std::mutex> lock(mutex_);
                 return default_logger_;
             }
-#endif
         } // namespace wrapper
 
-        sink_ptr make_colored_console_sink(const std::string& pattern, level_enum filter_level /*= info*/)
+        namespace
+        {
+            // background thread of flush_every, replaces spdlog's periodic worker
+            // so that the thread can be configured, it also writes the batches of the
+            // buffered console sinks which stay idle for s_max_buffered_interval
+            class periodic_flusher
+            {
+            public:
+                static periodic_flusher& instance()
+                {
+                    static periodic_flusher s_instance;
+                    return s_instance;
+                }
+                // flush all the loggers every `interval` (0: never), restarts the thread with `config`
+                void flush_every(std::chrono::seconds interval, const thread_config& config)
+                {
+                    std::lock_guard<std::mutex> control(control_mutex_);
+                    stop_thread_();
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        interval_ = std::max(interval, std::chrono::seconds::zero());
+                        config_ = config;
+                    }
+                    start_thread_();
+                }
+                // write the batch of `sink` at least every s_max_buffered_interval, starts the thread if needed
+                void add_buffered_sink(const sink_ptr& sink)
+                {
+                    std::lock_guard<std::mutex> control(control_mutex_);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        buffered_sinks_.push_back(sink);
+                        if (active_)
+                        {
+                            woken_ = true;
+                            cv_.notify_one();
+                            return;
+                        }
+                    }
+                    stop_thread_(); // joins the thread which ended without work
+                    start_thread_();
+                }
+                void stop()
+                {
+                    std::lock_guard<std::mutex> control(control_mutex_);
+                    stop_thread_();
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    interval_ = std::chrono::seconds::zero();
+                    buffered_sinks_.clear();
+                }
+            private:
+                periodic_flusher()
+                {
+                    config_.name = "log-flusher";
+                }
+                ~periodic_flusher()
+                {
+                    stop();
+                }
+                // must be called with control_mutex_ held
+                void stop_thread_()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        active_ = false;
+                    }
+                    cv_.notify_one();
+                    if (thread_.joinable())
+                    {
+                        thread_.join();
+                    }
+                }
+                // must be called with control_mutex_ held
+                void start_thread_()
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (interval_ == std::chrono::seconds::zero() && buffered_sinks_.empty())
+                    {
+                        return;
+                    }
+                    active_ = true;
+                    thread_ = std::thread(&periodic_flusher::run_, this, config_);
+                }
+                void run_(thread_config config)
+                {
+                    apply_thread_config_or_warn(config);
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    auto next_flush = std::chrono::steady_clock::now() + interval_;
+                    while (active_)
+                    {
+                        const auto tick = buffered_sinks_.empty() ? interval_ : std::min(interval_, s_max_buffered_interval);
+                        const auto deadline = std::chrono::steady_clock::now() +
+                            (tick == std::chrono::seconds::zero() ? s_max_buffered_interval : tick);
+                        if (cv_.wait_until(lock, deadline, [this]() { return !active_ || woken_; }) && !active_)
+                        {
+                            break;
+                        }
+                        if (woken_)
+                        {
+                            // a sink was added during a long wait, restart with the short tick
+                            woken_ = false;
+                            continue;
+                        }
+                        std::vector<sink_ptr> sinks;
+                        for (auto it = buffered_sinks_.begin(); it != buffered_sinks_.end();)
+                        {
+                            if (auto sink = it->lock())
+                            {
+                                sinks.push_back(std::move(sink));
+                                ++it;
+                            }
+                            else
+                            {
+                                it = buffered_sinks_.erase(it);
+                            }
+                        }
+                        const bool flush_all = interval_ > std::chrono::seconds::zero() && std::chrono::steady_clock::now() >= next_flush;
+                        if (flush_all)
+                        {
+                            next_flush += interval_;
+                        }
+                        if (sinks.empty() && interval_ == std::chrono::seconds::zero())
+                        {
+                            active_ = false; // nothing left to do, add_buffered_sink starts a new thread
+                            break;
+                        }
+                        lock.unlock();
+                        for (auto& sink : sinks)
+                        {
+                            try
+                            {
+                                sink->flush();
+                            }
+                            catch (const std::exception& ex)
+                            {
+                                std::cerr << ex.what() << std::endl;
+                            }
+                        }
+                        sinks.clear();
+                        if (flush_all)
+                        {
+                            flush_all_();
+                        }
+                        lock.lock();
+                    }
+                }
+                static void flush_all_()
+                {
+#if defined(ENABLE_SPDLOG)
+                    spdlog::apply_all([](std::shared_ptr<spdlog::logger> logger) { logger->flush(); });
+#else
+                    auto logger = logger::manager::instance().get_default_logger();
+                    if (logger)
+                    {
+                        logger->flush();
+                    }
+#endif
+                }
+                // serializes the start and the stop of the thread
+                std::mutex control_mutex_;
+                std::mutex mutex_;
+                std::condition_variable cv_;
+                bool active_ = false;
+                bool woken_ = false;
+                std::chrono::seconds interval_{ 0 };
+                thread_config config_;
+                std::vector<std::weak_ptr<sink_ptr::element_type>> buffered_sinks_;
+                std::thread thread_;
+            };
+        } // namespace
+
+        sink_ptr make_colored_console_sink(const std::string& pattern, level_enum filter_level /*= info*/, color_mode mode /*= color_mode::automatic*/)
         {
+            const bool colored = mode == color_mode::always || (mode == color_mode::automatic && stdout_is_terminal());
 #if defined(ENABLE_SPDLOG)
-            auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            sink_ptr console_sink;
+            if (colored)
+            {
+                // spdlog still checks TERM in automatic mode, dumb terminals get no escape codes
+                console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>(
+                    mode == color_mode::always ? spdlog::color_mode::always : spdlog::color_mode::automatic);
+            }
+            else
+            {
+                console_sink = std::make_shared<buffered_stdout_sink>();
+            }
 #else
-            auto console_sink = std::make_shared<logger::console_sink>();
+            // the fallback sink has no colours, only the batching differs
+            auto console_sink = std::make_shared<logger::console_sink>(!colored);
 #endif
+            if (!colored)
+            {
+                periodic_flusher::instance().add_buffered_sink(console_sink);
+            }
+#if defined(ENABLE_SPDLOG)
+            console_sink->set_level(to_spdlog_level(filter_level));
+#else
             console_sink->set_level(filter_level);
+#endif
             //console_sink->set_pattern("%L | %X.%f | %t | %20!s:%-4# | %^%v%$");
             console_sink->set_pattern(pattern);
             return console_sink;
         }
 
-        sink_ptr make_daily_file_sink(const std::string& filepath, const std::string& pattern, level_enum filter_level, uint16_t max_files, int rotation_hour, int rotation_minute, bool truncate)
+        thread_config default_archiver_thread_config()
+        {
+            thread_config config;
+            config.name = "log-archiver";
+            config.nice = 19;
+            return config;
+        }
+
+        sink_ptr make_daily_file_sink(const std::string& filepath, const std::string& pattern, level_enum filter_level, uint16_t max_files, int rotation_hour, int rotation_minute, bool truncate, uint64_t max_total_bytes, const thread_config& archiver_config)
         {
 #if defined(ENABLE_SPDLOG)
-            auto file_sink = std::make_shared<spdlog::sinks::daily_file_sink_mt>(filepath, rotation_hour, rotation_minute, truncate, max_files);
+            sink_ptr file_sink;
+#if defined(ENABLE_LOG_COMPRESSION)
+            const bool archiving = true;
+#else
+            const bool archiving = max_total_bytes > 0;
+#endif
+            if (archiving)
+            {
+                file_sink = std::make_shared<daily_archiving_file_sink>(filepath, rotation_hour, rotation_minute, truncate, max_files, max_total_bytes, archiver_config);
+            }
+            else
+            {
+                file_sink = std::make_shared<spdlog::sinks::daily_file_sink_mt>(filepath, rotation_hour, rotation_minute, truncate, max_files);
+            }
 #else
             auto file_sink = std::make_shared<logger::file_sink>(filepath, truncate);
 #endif
+#if defined(ENABLE_SPDLOG)
+            file_sink->set_level(to_spdlog_level(filter_level));
+#else
             file_sink->set_level(filter_level);
+#endif
             file_sink->set_pattern(pattern);
             //file_sink->set_pattern("%5!l | %X.%f | %P | %t | %20!s:%-4# | %v");
             return file_sink;
         }
 
-        logger_ptr make_multisink_logger(const std::string& logger_name, sinks_init_list sinks, level_enum filter_level)
+        logger_ptr make_multisink_logger(const std::string& logger_name, sinks_init_list sinks, level_enum filter_level, clock_source clock, const thread_config& clock_config)
         {
+#if defined(ENABLE_SPDLOG)
+            auto logger = std::make_shared<logger_t>(std::make_shared<spdlog::logger>(logger_name, sinks));
+#else
             auto logger = std::make_shared<logger_t>(logger_name, sinks);
+#endif
+            logger->set_level(filter_level);
+            logger->set_clock(get_clock(clock, clock_config));
+            logger::register_logger(logger);
+            return logger;
+        }
+
+        logger_ptr make_async_multisink_logger(const std::string& logger_name, sinks_init_list sinks, level_enum filter_level, clock_source clock, const thread_config& clock_config)
+        {
+#if defined(ENABLE_SPDLOG)
+            auto thread_pool = spdlog::thread_pool();
+            if (!thread_pool)
+            {
+                init_thread_pool(spdlog::details::default_async_q_size, 1);
+                thread_pool = spdlog::thread_pool();
+            }
+            auto logger = std::make_shared<logger_t>(std::make_shared<spdlog::async_logger>(logger_name, sinks, std::move(thread_pool), spdlog::async_overflow_policy::block));
             logger->set_level(filter_level);
+            logger->set_clock(get_clock(clock, clock_config));
             logger::register_logger(logger);
             return logger;
+#else
+            return make_multisink_logger(logger_name, sinks, filter_level, clock, clock_config);
+#endif
+        }
+
+        void init_thread_pool(size_t queue_size, size_t thread_count, const thread_config& config)
+        {
+#if defined(ENABLE_SPDLOG)
+            spdlog::init_thread_pool(queue_size, thread_count, [config]() { apply_thread_config_or_warn(config); });
+#endif
         }
 
         void register_logger(logger_ptr logger)
         {
 #if defined(ENABLE_SPDLOG)
-            spdlog::register_logger(logger);
+            spdlog::register_logger(logger->impl());
 #endif
         }
 
         void set_default_logger(logger_ptr logger)
         {
 #if defined(ENABLE_SPDLOG)
-            spdlog::set_default_logger(logger);
-#else
-            manager::instance().set_default_logger(logger);
+            // keep spdlog's own default in sync for code using spdlog directly
+            spdlog::set_default_logger(logger ? logger->impl() : nullptr);
 #endif
+            manager::instance().set_default_logger(logger);
         }
 
         logger_ptr get_default_logger()
         {
-#if defined(ENABLE_SPDLOG)
-            return spdlog::default_logger();
-#else
             return logger::manager::instance().get_default_logger();
-#endif
         }
 
         void flush_on(level_enum log_level)
         {
 #if defined(ENABLE_SPDLOG)
-            spdlog::flush_on(log_level);
+            spdlog::flush_on(to_spdlog_level(log_level));
 #else
             logger::manager::instance().get_default_logger()->flush_on(log_level);
 #endif
         }
 
-        void flush_every(std::chrono::seconds interval)
+        void flush_every(std::chrono::seconds interval, const thread_config& config)
         {
-#if defined(ENABLE_SPDLOG)
-            spdlog::flush_every(interval);
-#endif
+            periodic_flusher::instance().flush_every(interval, config);
         }
 
         void shutdown()
         {
+            periodic_flusher::instance().stop();
 #if defined(ENABLE_SPDLOG)
             spdlog::shutdown();
+            // spdlog::shutdown() dropped its default logger, drop the handle too so that
+            // the LOG_* calls after shutdown (static destructors...) do nothing again
+            manager::instance().set_default_logger(nullptr);
+#else
+            auto logger = logger::manager::instance().get_default_logger();
+            if (logger)
+            {
+                logger->flush();
+            }
 #endif
         }
 
@@ -258,16 +720,23 @@ namespace example
     bool LogStream::operator==(const LogLine& line)
     {
 #if defined(ENABLE_SPDLOG)
-        m_log->log(spdlog::source_loc{ m_file_,m_line_,m_func_ }, m_level_, "{}", line.str());
+        const auto msg = line.str();
+        m_log->impl()->log(m_log->now(), spdlog::source_loc{ m_file_,m_line_,m_func_ }, logger::to_spdlog_level(m_level_), spdlog::string_view_t(msg.data(), msg.size()));
 #else
         static const char* level_str[] = { "T", "D", "I", "W", "E", "C", "O" };
         std::ostringstream ss;
-        const auto now = std::chrono::system_clock::now();
+        const auto now = m_log->now();
         auto us = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
         const std::time_t now_tt = std::chrono::system_clock::to_time_t(now);
         auto file = std::string(m_file_);
-        char sztime[16] = { 0 };
-        std::strftime(sztime, sizeof(sztime), "%T", std::localtime(&now_tt));
+        // localtime/strftime only once per second and thread
+        static thread_local std::time_t s_cached_tt = -1;
+        static thread_local char sztime[16] = { 0 };
+        if (now_tt != s_cached_tt)
+        {
+            std::strftime(sztime, sizeof(sztime), "%T", std::localtime(&now_tt));
+            s_cached_tt = now_tt;
+        }
         ss << level_str[m_level_]
             //!!! not defined in gcc 4.8.3
             //<< " | " << std::put_time(std::localtime(&now_tt), "%T") << "." << std::setfill('0') << std::setw(6) << us << std::setfill(' ')
@@ -2,6 +2,7 @@
 #define __LOGGER_WRAPPER__
 
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,14 +12,23 @@
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include "thread_config.h"
+#include "log_clock.h"
+
+#ifndef CURRENT_FUNCTION
+#   define CURRENT_FUNCTION static_cast<const char *>(__FUNCTION__)
+#endif
 
 #if defined(ENABLE_SPDLOG)
-#   include "spdlog/spdlog.h"
-#   define CURRENT_FUNCTION SPDLOG_FUNCTION
-#else
-#   ifndef CURRENT_FUNCTION
-#       define CURRENT_FUNCTION static_cast<const char *>(__FUNCTION__)
-#   endif
+// spdlog is kept out of this header, only logger_wrapper.cpp and logger_wrapper_fmt.h include it
+namespace spdlog
+{
+    class logger;
+    namespace sinks
+    {
+        class sink;
+    }
+}
 #endif
 
 namespace example
@@ -27,23 +37,7 @@ namespace example
     {
         inline namespace wrapper
         {
-#if defined(ENABLE_SPDLOG)
-            using spdlog::level::trace;
-            using spdlog::level::debug;
-            using spdlog::level::info;
-            using spdlog::level::warn;
-            using spdlog::level::err;
-            using spdlog::level::critical;
-            using spdlog::level::off;
-            using spdlog::level::n_levels;
-
-            using level_enum = spdlog::level::level_enum;
-            using level_t = spdlog::level_t;
-            using sink_ptr = spdlog::sink_ptr;
-            using sinks_init_list = spdlog::sinks_init_list;
-            using logger_t = spdlog::logger;
-            using logger_ptr = std::shared_ptr<logger_t>;
-#else
+            // same values as spdlog::level::level_enum
             enum level_enum {
                 trace,
                 debug,
@@ -56,6 +50,45 @@ namespace example
             };
             using level_t = std::atomic<int>;
 
+            // colour handling of the console sink
+            enum class color_mode {
+                // colours when stdout is a terminal, otherwise plain batched output
+                automatic,
+                // colours even if stdout is not a terminal
+                always,
+                // plain batched output
+                never
+            };
+
+#if defined(ENABLE_SPDLOG)
+            using sink_ptr = std::shared_ptr<spdlog::sinks::sink>;
+            using sinks_init_list = std::initializer_list<sink_ptr>;
+
+            // handle of a spdlog logger, the spdlog instance is reachable by impl()
+            // once logger_wrapper_fmt.h is included
+            class logger_t
+            {
+            public:
+                explicit logger_t(std::shared_ptr<spdlog::logger> impl);
+                ~logger_t();
+                logger_t(const logger_t& other) = delete;
+                logger_t& operator=(const logger_t& other) = delete;
+                void set_level(level_enum log_level);
+                level_enum level() const;
+                bool should_log(level_enum msg_level) const;
+                void flush_on(level_enum log_level);
+                void flush();
+                // clock of the records, set it before the logger is shared
+                void set_clock(clock_fn clock) { clock_.store(clock, std::memory_order_relaxed); }
+                std::chrono::system_clock::time_point now() const { return clock_.load(std::memory_order_relaxed)(); }
+                const std::shared_ptr<spdlog::logger>& impl() const { return impl_; }
+            private:
+                std::shared_ptr<spdlog::logger> impl_;
+                std::atomic<clock_fn> clock_{ get_clock(clock_source::system) };
+            };
+            using logger_ptr = std::shared_ptr<logger::logger_t>;
+#else
+
             class sink
             {
             public:
@@ -74,7 +107,8 @@ namespace example
             class console_sink : public sink
             {
             public:
-                console_sink();
+                // a buffered sink batches the writes, see make_colored_console_sink
+                explicit console_sink(bool buffered = false);
                 ~console_sink() override;
                 console_sink(const console_sink& other) = delete;
                 console_sink& operator=(const console_sink& other) = delete;
@@ -86,8 +120,13 @@ namespace example
                     static std::mutex s_mutex;
                     return s_mutex;
                 }
+                void write_buffer_();
                 std::ostream& out_;
                 std::mutex& mutex_;
+                const bool buffered_;
+                std::string buffer_;
+                size_t buffered_lines_{ 0 };
+                std::chrono::steady_clock::time_point last_write_;
             };
             class file_sink : public sink
             {
@@ -129,6 +168,10 @@ namespace example
                 level_enum level() const;
                 bool should_log(level_enum msg_level) const;
                 void flush_on(level_enum log_level);
+                void flush();
+                // clock of the records, set it before the logger is shared
+                void set_clock(clock_fn clock) { clock_.store(clock, std::memory_order_relaxed); }
+                std::chrono::system_clock::time_point now() const { return clock_.load(std::memory_order_relaxed)(); }
                 void write_log(level_enum msg_level, const std::string& msg);
             protected:
                 bool should_flush_(level_enum msg_level);
@@ -137,8 +180,10 @@ namespace example
                 std::vector<sink_ptr> sinks_;
                 level_t level_{ logger::info };
                 level_t flush_level_{ logger::off };
+                std::atomic<clock_fn> clock_{ get_clock(clock_source::system) };
             };
             using logger_ptr = std::shared_ptr<logger::logger_t>;
+#endif
 
             class manager
             {
@@ -151,26 +196,51 @@ namespace example
             private:
                 manager();
                 ~manager() = default;
+                std::mutex mutex_;
                 logger_ptr default_logger_;
             };
-#endif
         } // namespace wrapper
 
-        // make a colored console sink
-        sink_ptr make_colored_console_sink(const std::string& pattern, level_enum filter_level = info);
-        // make a daily file sink which rotates on given time
+        // make a colored console sink, with `color_mode::automatic` it checks once whether stdout is a terminal,
+        // if not the colours are dropped and the lines are written in batches (every 64 lines or 1 second,
+        // and on flush) instead of one write per record, an idle batch is written within 1 second by the
+        // thread of flush_every which is started for it if needed (named `log-flusher` unless configured)
+        sink_ptr make_colored_console_sink(const std::string& pattern, level_enum filter_level = info,
+            color_mode mode = color_mode::automatic);
+        // settings of the archiver thread of the daily file sinks: named `log-archiver`, nice 19
+        // so that the compression never competes with the logging threads
+        thread_config default_archiver_thread_config();
+        // make a daily file sink which rotates on given time, when built with ENABLE_LOG_COMPRESSION the closed
+        // files are gzipped by a background thread, the history is limited to `max_files` files and
+        // `max_total_bytes` bytes (0: no limit), the archiver thread applies `archiver_config` on start
+        // !!only rotates with spdlog, otherwise it is a plain file sink
         sink_ptr make_daily_file_sink(const std::string& filepath, const std::string& pattern, level_enum filter_level = trace,
             uint16_t max_files = 30,
             int rotation_hour = 23,
             int rotation_minute = 59,
-            bool truncate = false);
+            bool truncate = false,
+            uint64_t max_total_bytes = 0,
+            const thread_config& archiver_config = default_archiver_thread_config());
+        // `clock` is the timestamp source of the records written through the LOG_* and LOG_*_FMT macros,
+        // `clock_config` is applied by the background thread of the `cached` clock when this call starts it
         logger_ptr make_multisink_logger(const std::string& logger_name, sinks_init_list sinks,
-            level_enum filter_level = trace);
+            level_enum filter_level = trace, clock_source clock = clock_source::system,
+            const thread_config& clock_config = default_clock_thread_config());
+        // make a logger whose sinks are written from the thread pool created by init_thread_pool,
+        // !!only available with spdlog, otherwise it is the same as make_multisink_logger
+        logger_ptr make_async_multisink_logger(const std::string& logger_name, sinks_init_list sinks,
+            level_enum filter_level = trace, clock_source clock = clock_source::system,
+            const thread_config& clock_config = default_clock_thread_config());
+        // create the thread pool of the async loggers, every pool thread applies `config` on start,
+        // !!only available with spdlog, otherwise it does nothing
+        void init_thread_pool(size_t queue_size, size_t thread_count, const thread_config& config = thread_config());
         void register_logger(logger_ptr logger);
         void set_default_logger(logger_ptr logger);
         logger_ptr get_default_logger();
         void flush_on(level_enum log_level);
-        void flush_every(std::chrono::seconds interval);
+        // flush the loggers periodically from a background thread which applies `config` on start,
+        // the same thread writes the idle batches of the buffered console sinks, 0 only keeps that part
+        void flush_every(std::chrono::seconds interval, const thread_config& config = thread_config());
         void shutdown();
     } // namespace logger
 
@@ -204,27 +274,7 @@ namespace example
 } // namespace example
 
 
-#if defined(ENABLE_SPDLOG)
-//////////////////////////////////////////////////////////////////////////
-// Use the fmt mode output of sdplog
-#define LOG_WITH_LOGGER_LEVEL_FMT(logger, level, ...)   SPDLOG_LOGGER_CALL((logger), (level), __VA_ARGS__)
-#define LOG_WITH_LEVEL_FMT(level, ...)                  LOG_WITH_LOGGER_LEVEL_FMT(example::logger::get_default_logger(), level, __VA_ARGS__)
-
-// !!This macros only available with spdlog, otherwise it does nothing
-#define LOG_TRACE_FMT(...)                      LOG_WITH_LEVEL_FMT(example::logger::trace, __VA_ARGS__)
-#define LOG_DEBUG_FMT(...)                      LOG_WITH_LEVEL_FMT(example::logger::debug, __VA_ARGS__)
-#define LOG_INFO_FMT(...)                       LOG_WITH_LEVEL_FMT(example::logger::info, __VA_ARGS__)
-#define LOG_WARNING_FMT(...)                    LOG_WITH_LEVEL_FMT(example::logger::warn, __VA_ARGS__)
-#define LOG_ERROR_FMT(...)                      LOG_WITH_LEVEL_FMT(example::logger::err, __VA_ARGS__)
-#define LOG_CRITICAL_FMT(...)                   LOG_WITH_LEVEL_FMT(example::logger::critical, __VA_ARGS__)
-#else
-#define LOG_TRACE_FMT(...)
-#define LOG_DEBUG_FMT(...)
-#define LOG_INFO_FMT(...)
-#define LOG_WARNING_FMT(...)
-#define LOG_ERROR_FMT(...)
-#define LOG_CRITICAL_FMT(...)
-#endif
+// The fmt mode macros (LOG_INFO_FMT...) are defined in logger_wrapper_fmt.h
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,65 @@
+#ifndef __LOGGER_WRAPPER_FMT__
+#define __LOGGER_WRAPPER_FMT__
+
+// fmt mode output of the logger wrapper, this header pulls in spdlog and fmt,
+// include it only in the translation units which really use the macros below
+
+#include "logger_wrapper.h"
+
+#if defined(ENABLE_SPDLOG)
+#   include <iterator>
+#   include <utility>
+#   include "spdlog/spdlog.h"
+
+namespace example
+{
+    namespace logger
+    {
+        // format the record and hand it to spdlog with the timestamp of the logger's clock,
+        // SPDLOG_LOGGER_CALL would stamp it with spdlog's own clock
+        template <typename... Args>
+        inline void log_fmt(const logger_ptr& log, level_enum lvl, const spdlog::source_loc& loc,
+            spdlog::format_string_t<Args...> format, Args&&... args)
+        {
+            if (!log || !log->should_log(lvl))
+            {
+                return;
+            }
+            const auto now = log->now();
+            try
+            {
+                spdlog::memory_buf_t buf;
+                fmt::format_to(std::back_inserter(buf), format, std::forward<Args>(args)...);
+                log->impl()->log(now, loc, static_cast<spdlog::level::level_enum>(lvl), spdlog::string_view_t(buf.data(), buf.size()));
+            }
+            catch (const std::exception& ex)
+            {
+                std::cerr << "logger::log_fmt: " << ex.what() << std::endl;
+            }
+        }
+    } // namespace logger
+} // namespace example
+
+//////////////////////////////////////////////////////////////////////////
+// Use the fmt mode output of sdplog, stamped by the clock of the logger like the stream macros
+#define LOG_WITH_LOGGER_LEVEL_FMT(log, lvl, ...)        example::logger::log_fmt((log), (lvl), spdlog::source_loc{ __FILE__, __LINE__, CURRENT_FUNCTION }, __VA_ARGS__)
+#define LOG_WITH_LEVEL_FMT(level, ...)                  LOG_WITH_LOGGER_LEVEL_FMT(example::logger::get_default_logger(), level, __VA_ARGS__)
+
+// !!This macros only available with spdlog, otherwise it does nothing
+#define LOG_TRACE_FMT(...)                      LOG_WITH_LEVEL_FMT(example::logger::trace, __VA_ARGS__)
+#define LOG_DEBUG_FMT(...)                      LOG_WITH_LEVEL_FMT(example::logger::debug, __VA_ARGS__)
+#define LOG_INFO_FMT(...)                       LOG_WITH_LEVEL_FMT(example::logger::info, __VA_ARGS__)
+#define LOG_WARNING_FMT(...)                    LOG_WITH_LEVEL_FMT(example::logger::warn, __VA_ARGS__)
+#define LOG_ERROR_FMT(...)                      LOG_WITH_LEVEL_FMT(example::logger::err, __VA_ARGS__)
+#define LOG_CRITICAL_FMT(...)                   LOG_WITH_LEVEL_FMT(example::logger::critical, __VA_ARGS__)
+#else
+#define LOG_TRACE_FMT(...)
+#define LOG_DEBUG_FMT(...)
+#define LOG_INFO_FMT(...)
+#define LOG_WARNING_FMT(...)
+#define LOG_ERROR_FMT(...)
+#define LOG_CRITICAL_FMT(...)
+#endif
+
+
+#endif // #ifndef __LOGGER_WRAPPER_FMT__
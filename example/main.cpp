@@ -3,9 +3,12 @@
 #include <chrono>
 #include <atomic>
 #include <thread>
+#include <vector>
+#include <utility>
 #include <ctime> // import srand rand time
 #include "logger_wrapper.h"
 #include "ZkMSFifo.h"
+#include "ZkObjectPool.h"
 
 using namespace std;
 using namespace example;
@@ -19,11 +22,15 @@ public:
             "global-logger",
             {
                 logger::make_colored_console_sink("%L | %X.%f | %5t | %20!s:%-4# | %^%v%$", logger::debug),
-                logger::make_daily_file_sink("./example-log.log", "%5!l | %X.%f | %P | %5t | %20!s:%-4# | %v", logger::trace),
+                // 30 days but never more than 64MiB of history
+                logger::make_daily_file_sink("./example-log.log", "%5!l | %X.%f | %P | %5t | %20!s:%-4# | %v", logger::trace,
+                    30, 23, 59, false, 64 * 1024 * 1024),
             },
             logger::trace));
         logger::flush_on(logger::debug);
-        logger::flush_every(std::chrono::seconds(3));
+        thread_config flusher;
+        flusher.name = "log-flusher";
+        logger::flush_every(std::chrono::seconds(3), flusher);
         LOG_DEBUG << "logger init";
 
         srand(time(nullptr));
@@ -45,7 +52,7 @@ public:
 static Initializer s_initializer;
 
 
-class Action
+class Action : public ZKFifoHook<Action, ZKPoolDeleter<Action>>
 {
 public:
     Action() : m_seq_(s_initializer.genSequence()) {
@@ -53,30 +60,63 @@ public:
     }
     ~Action() = default;
 
+    /// how long process() takes
+    static std::chrono::seconds runTime() {
+        return std::chrono::seconds(3);
+    }
     void process() {
         LOG_INFO << "process action... seq=" << m_seq_;
-        std:this_thread::sleep_for(std::chrono::seconds(3));
+        std::this_thread::sleep_for(runTime());
         m_ret_.set_value(m_seq_);
     }
 
+    /// fail the future with `future_error` instead of running the action late
+    void reject() {
+        LOG_WARNING << "reject expired action, seq=" << m_seq_;
+        // abandoning the shared state makes the future throw `broken_promise`
+        std::promise<std::string>().swap(m_ret_);
+    }
+
+    /// the caller stops waiting for the result at `deadline`, the action is rejected
+    /// if it is started too late to be done by then
+    void setDeadline(std::chrono::steady_clock::time_point deadline) {
+        m_deadline_ = deadline;
+    }
+    bool expired() const {
+        return std::chrono::steady_clock::now() + runTime() > m_deadline_;
+    }
+
     std::string m_seq_;
     std::promise<std::string> m_ret_;
+    std::chrono::steady_clock::time_point m_deadline_{ std::chrono::steady_clock::time_point::max() };
 };
 
+using ActionPool = ZKObjectPool<Action>;
+using ActionPtr = ActionPool::obj_ptr_t;
+
 class ActionProcessor
 {
 public:
+    /// priority lanes, actions of a lane are only processed when all the
+    /// more urgent lanes are empty
+    enum Priority {
+        High,
+        Normal,
+        Bulk,
+        n_priorities
+    };
+
     ActionProcessor() {}
     virtual ~ActionProcessor() {
         stop();
     }
-    void addAction(Action* act) {
-        m_actions_.add(act);
+    void addAction(ActionPtr act, Priority prio = Normal) {
+        m_actions_.add(std::move(act), prio);
     }
     bool start() {
         if (!m_running_)
         {
-            m_worker_ = std::thread(&ActionProcessor::doWork, this);
+            m_worker_ = std::thread(&ActionProcessor::threadMain, this);
         }
         return m_running_;
     }
@@ -90,7 +130,18 @@ public:
     void setPeaceStop(bool peace = true) {
         m_peace_stop_ = peace;
     }
+    /// settings applied by the worker thread on start, call it before start()
+    void setThreadConfig(const thread_config& config) {
+        m_thread_config_ = config;
+    }
 protected:
+    void threadMain() {
+        if (!apply_thread_config(m_thread_config_))
+        {
+            LOG_WARNING << "failed to apply thread config, name=" << m_thread_config_.name;
+        }
+        doWork();
+    }
     virtual void doWork() {
         LOG_DEBUG << "worker thread started, id=" << std::this_thread::get_id();
         m_running_ = true;
@@ -99,7 +150,7 @@ protected:
             auto action = m_actions_.getNext(std::chrono::milliseconds(10));
             if (action)
             {
-                action->process();
+                run(*action);
             }
         }
         cleanup();
@@ -113,7 +164,7 @@ protected:
             while (!m_actions_.empty())
             {
                 auto action = m_actions_.getNext();
-                action->process();
+                run(*action);
             }
         }
         else
@@ -125,10 +176,22 @@ protected:
         }
     }
 
+    void run(Action& action) {
+        if (action.expired())
+        {
+            action.reject();
+        }
+        else
+        {
+            action.process();
+        }
+    }
+
     bool m_peace_stop_ = false;
+    thread_config m_thread_config_;
     std::thread m_worker_;
     std::atomic_bool m_running_{ false };
-    ZKMSFifo<Action> m_actions_;
+    ZKMSIntrusiveFifo<Action, ZKPoolDeleter<Action>, n_priorities> m_actions_;
 };
 
 class CPUWaster : public ActionProcessor
@@ -153,36 +216,58 @@ class CPUWaster : public ActionProcessor
 
 int main()
 {
+    // declared before the processors so it outlives the actions they hold
+    ActionPool actionPool;
+    actionPool.reserve(16);
+
     ActionProcessor pro;
+    thread_config worker;
+    worker.name = "action-worker";
     pro.setPeaceStop();
+    pro.setThreadConfig(worker);
     pro.start();
 
+    thread_config wasterConfig;
+    wasterConfig.name = "cpu-waster";
+    wasterConfig.nice = 10; // background noise, never compete with the worker
     CPUWaster waster;
+    waster.setThreadConfig(wasterConfig);
     waster.start();
 
-    for (int i = 0; i < 10; ++i) {
-        auto action = new Action();
-        auto ret = action->m_ret_.get_future();
-        pro.addAction(action);
-        auto status = ret.wait_for(std::chrono::seconds(2));
-        if (status == std::future_status::ready)
-        {
-            try
+    for (int batch = 0; batch < 3; ++batch) {
+        // nobody waits for the results after 7s: the first two actions of the batch are done
+        // in time, the third one would start after 6s and is rejected instead of running late
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(7);
+        std::vector<std::pair<std::string, std::future<std::string>>> results;
+        for (int i = 0; i < 3; ++i) {
+            auto action = actionPool.acquire();
+            results.emplace_back(action->m_seq_, action->m_ret_.get_future());
+            action->setDeadline(deadline);
+            pro.addAction(std::move(action), i == 0 ? ActionProcessor::High : ActionProcessor::Normal);
+        }
+        for (auto& result : results) {
+            const auto& seq = result.first;
+            auto& ret = result.second;
+            auto status = ret.wait_until(deadline);
+            if (status == std::future_status::ready)
             {
-                LOG_INFO << "future get result=" << ret.get();
+                try
+                {
+                    LOG_INFO << "future get result=" << ret.get();
+                }
+                catch (std::future_error& ex)
+                {
+                    LOG_ERROR << "future_error for action, seq=" << seq << ", ex:" << ex.what();
+                }
             }
-            catch (std::future_error& ex)
+            else if (status == std::future_status::timeout)
             {
-                LOG_ERROR << "future_error for action, seq=" << action->m_seq_ << ", ex:" << ex.what();
+                LOG_WARNING << "timeout wait for action, seq=" << seq;
+            }
+            else
+            {
+                LOG_ERROR << "future status is deferred for action, seq=" << seq;
             }
-        }
-        else if (status == std::future_status::timeout)
-        {
-            LOG_WARNING << "timeout wait for action, seq=" << action->m_seq_;
-        }
-        else
-        {
-            LOG_ERROR << "future status is deferred for action, seq=" << action->m_seq_;
         }
     }
 
@@ -0,0 +1,77 @@
+#include "thread_config.h"
+
+#include <iostream>
+
+#if defined(__linux__)
+#   include <pthread.h>
+#   include <sched.h>
+#   include <sys/resource.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#elif defined(_WIN32)
+#   include <windows.h>
+#endif
+
+namespace example
+{
+    bool apply_thread_config(const thread_config& config)
+    {
+        bool ok = true;
+#if defined(__linux__)
+        if (!config.name.empty())
+        {
+            // the kernel limits thread names to 16 bytes including the terminator
+            ok &= pthread_setname_np(pthread_self(), config.name.substr(0, 15).c_str()) == 0;
+        }
+        if (!config.cpus.empty())
+        {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            for (int cpu : config.cpus)
+            {
+                if (cpu >= 0 && cpu < CPU_SETSIZE)
+                {
+                    CPU_SET(cpu, &cpuset);
+                }
+            }
+            ok &= pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0;
+        }
+        if (config.policy >= 0)
+        {
+            sched_param param{};
+            param.sched_priority = config.priority;
+            ok &= pthread_setschedparam(pthread_self(), config.policy, &param) == 0;
+        }
+        if (config.nice != 0)
+        {
+            // under linux the nice value is per thread when addressed by tid
+            ok &= setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), config.nice) == 0;
+        }
+#elif defined(_WIN32)
+        if (!config.cpus.empty())
+        {
+            DWORD_PTR mask = 0;
+            for (int cpu : config.cpus)
+            {
+                if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+                {
+                    mask |= static_cast<DWORD_PTR>(1) << cpu;
+                }
+            }
+            ok &= SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+        }
+        // thread names and scheduling policies are not supported here
+#else
+        ok = config.name.empty() && config.cpus.empty() && config.nice == 0 && config.policy < 0;
+#endif
+        return ok;
+    }
+
+    void apply_thread_config_or_warn(const thread_config& config)
+    {
+        if (!apply_thread_config(config))
+        {
+            std::cerr << "failed to apply thread config for thread '" << config.name << "'" << std::endl;
+        }
+    }
+} // namespace example
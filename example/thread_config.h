@@ -0,0 +1,34 @@
+#ifndef __THREAD_CONFIG__
+#define __THREAD_CONFIG__
+
+#include <string>
+#include <vector>
+
+namespace example
+{
+    // Scheduling settings of a thread, the default constructed value leaves
+    // the thread untouched.
+    struct thread_config
+    {
+        // thread name shown by top/ps, truncated to 15 chars under linux
+        std::string name;
+        // cpus the thread is allowed to run on, empty keeps the inherited mask
+        std::vector<int> cpus;
+        // nice value of the thread (-20..19), 0 keeps the inherited one
+        int nice = 0;
+        // scheduling policy (SCHED_OTHER, SCHED_FIFO, SCHED_RR...), -1 keeps the inherited one
+        int policy = -1;
+        // static priority used with `policy`, only meaningful for realtime policies
+        int priority = 0;
+    };
+
+    // apply the settings to the calling thread,
+    // return false if any of them could not be applied
+    bool apply_thread_config(const thread_config& config);
+
+    // same as apply_thread_config but reports a failure on stderr, for the
+    // background threads which have nobody to return it to
+    void apply_thread_config_or_warn(const thread_config& config);
+} // namespace example
+
+#endif // #ifndef __THREAD_CONFIG__
@@ -0,0 +1,98 @@
+// Representative logging/queue workload, used as the training run of the PGO build
+// and as a quick throughput check:
+//   example_workload [producer threads] [records per producer]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logger_wrapper_fmt.h"
+#include "ZkMSFifo.h"
+#include "ZkObjectPool.h"
+
+using namespace example;
+
+namespace
+{
+    struct Message : public ZKFifoHook<Message, ZKPoolDeleter<Message>>
+    {
+        Message(int producer, int seq) : m_producer_(producer), m_seq_(seq) {}
+        int m_producer_;
+        int m_seq_;
+    };
+
+    using MessageFifo = ZKMSIntrusiveFifo<Message, ZKPoolDeleter<Message>, 2>;
+
+    void produce(int id, int records, ZKObjectPool<Message>& pool, MessageFifo& fifo)
+    {
+        thread_config config;
+        config.name = "producer-" + std::to_string(id);
+        apply_thread_config_or_warn(config);
+        for (int i = 0; i < records; ++i)
+        {
+            // mixed levels, trace/debug are filtered by the console sink or by the logger
+            switch (i % 8)
+            {
+            case 0: LOG_TRACE << "trace record, producer=" << id << ", seq=" << i; break;
+            case 1: LOG_DEBUG << "debug record, producer=" << id << ", seq=" << i; break;
+            case 2: LOG_DEBUG_FMT("debug fmt record, producer={}, seq={}", id, i); break;
+            case 3: LOG_INFO_FMT("info fmt record, producer={}, seq={}", id, i); break;
+            case 7: LOG_WARNING << "warning record, producer=" << id << ", seq=" << i; break;
+            default: LOG_INFO << "info record, producer=" << id << ", seq=" << i; break;
+            }
+            fifo.add(pool.acquire(id, i), i % 16 == 0 ? 0 : 1);
+        }
+    }
+
+    void consume(long total, MessageFifo& fifo)
+    {
+        thread_config config;
+        config.name = "consumer";
+        apply_thread_config_or_warn(config);
+        for (long i = 0; i < total; ++i)
+        {
+            auto msg = fifo.getNext();
+            if (msg->m_seq_ % 64 == 0)
+            {
+                LOG_INFO << "consumed, producer=" << msg->m_producer_ << ", seq=" << msg->m_seq_;
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int producers = argc > 1 ? std::max(1, std::atoi(argv[1])) : 4;
+    const int records = argc > 2 ? std::max(1, std::atoi(argv[2])) : 50000;
+
+    logger::set_default_logger(logger::make_multisink_logger(
+        "workload-logger",
+        {
+            logger::make_colored_console_sink("%L | %X.%f | %5t | %20!s:%-4# | %^%v%$", logger::warn),
+            logger::make_daily_file_sink("./example-workload.log", "%5!l | %X.%f | %P | %5t | %20!s:%-4# | %v", logger::trace),
+        },
+        logger::debug));
+    logger::flush_on(logger::warn);
+    logger::flush_every(std::chrono::seconds(1));
+
+    ZKObjectPool<Message> pool(1024);
+    MessageFifo fifo;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread consumer(consume, static_cast<long>(producers) * records, std::ref(fifo));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < producers; ++i)
+    {
+        threads.emplace_back(produce, i, records, std::ref(pool), std::ref(fifo));
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    consumer.join();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_WARNING << producers << " producers x " << records << " records done in " << elapsed.count() << " ms";
+
+    logger::shutdown();
+    return 0;
+}